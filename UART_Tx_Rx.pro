@@ -21,11 +21,20 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
     main.cpp \
     mainwindow.cpp \
-    serialporthandler.cpp
+    portmonitor.cpp \
+    protocolutils.cpp \
+    serialporthandler.cpp \
+    timinganalysis.cpp \
+    trafficrecorder.cpp
 
 HEADERS += \
     mainwindow.h \
-    serialporthandler.h
+    monotonicclock.h \
+    portmonitor.h \
+    protocolutils.h \
+    serialporthandler.h \
+    timinganalysis.h \
+    trafficrecorder.h
 
 FORMS += \
     mainwindow.ui
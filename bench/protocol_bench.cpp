@@ -0,0 +1,388 @@
+#include "protocolutils.h"
+#include "serialporthandler.h"
+#include "trafficrecorder.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+//********************** Allocation counting *********************************
+// glibc       : every malloc/calloc/realloc (Qt containers and operator new both end there)
+// MSVC debug  : _CrtSetAllocHook sees every CRT heap allocation
+// otherwise   : not available, allocsPerOp is reported as -1
+
+static std::atomic<qint64> allocationCount(0);
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+static const char *allocationCounter = "malloc";
+static void installAllocationCounter() {}
+#elif defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+
+static int countAllocations(int allocType, void *, size_t, int, long, const unsigned char *, int)
+{
+    if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC)
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return 1; // let the allocation proceed
+}
+
+static const char *allocationCounter = "_CrtSetAllocHook";
+static void installAllocationCounter() { _CrtSetAllocHook(countAllocations); }
+#else
+static const char *allocationCounter = "none";
+static void installAllocationCounter() {}
+#endif
+
+static bool allocationCountingAvailable()
+{
+    return strcmp(allocationCounter, "none") != 0;
+}
+
+//********************** Bench runner ****************************************
+
+namespace
+{
+struct benchResult
+{
+    QString name;
+    qint64 iterations;
+    qint64 bytesPerOp;
+    double nsPerOp;
+    double nsPerByte;
+    double allocsPerOp;
+    QJsonObject extra;  // case specific figures, printed after the table
+};
+
+volatile quint32 sink = 0; // keeps results alive
+
+// CPU time of the whole process (all threads, user + system)
+qint64 processCpuNs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+        return 0;
+    auto toNs = [](const FILETIME &time) {
+        return ((static_cast<qint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 100;
+    };
+    return toNs(kernel) + toNs(user);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (static_cast<qint64>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000
+            + (static_cast<qint64>(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+#endif
+}
+
+// Recording of several ports at line rate : feeds `seconds` of wire traffic per port in
+// readAll() sized chunks as fast as possible, then relates the CPU time (caller + writer
+// thread) and file size to the wire time / wire bytes the capture represents.
+benchResult runRecorderBench(const QString &name, int ports, qint32 baudRate, int seconds, int chunkBytes)
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("bench.urec");
+
+    const qint64 bytesPerPort = static_cast<qint64>(baudRate) / 10 * seconds;
+    const qint64 chunksPerPort = bytesPerPort / chunkBytes;
+    const qint64 chunkWireNs = static_cast<qint64>(chunkBytes) * 10 * 1000000000 / baudRate;
+
+    // Traffic like the device sends : ACK frames with changing value bytes
+    QVector<QByteArray> payloads;
+    for (int p = 0; p < 64; ++p)
+    {
+        QByteArray payload;
+        while (payload.size() < chunkBytes)
+        {
+            QByteArray frame = QByteArray::fromHex("41434B00");
+            frame[3] = static_cast<char>(QRandomGenerator::global()->bounded(256));
+            frame.append(static_cast<char>(protocolUtils::calculateChecksum(frame)));
+            payload.append(frame);
+        }
+        payloads << payload.left(chunkBytes);
+    }
+
+    trafficRecorder recorder;
+    recorder.setMaxQueuedChunks(1 << 20); // measure cost, not drops
+
+    qint64 allocsBefore = allocationCount.load();
+    qint64 cpuBefore = processCpuNs();
+    QElapsedTimer timer;
+    timer.start();
+
+    recorder.startRecording(path);
+    for (qint64 c = 0; c < chunksPerPort; ++c)
+    {
+        for (int port = 0; port < ports; ++port)
+        {
+            recorder.record(static_cast<quint8>(port), trafficRecorder::Rx,
+                            payloads[(c + port) % payloads.size()], c * chunkWireNs);
+        }
+    }
+    recorder.stopRecording(); // includes draining and compressing the last chunks
+
+    qint64 wallNs = timer.nsecsElapsed();
+    qint64 cpuNs = processCpuNs() - cpuBefore;
+    qint64 allocs = allocationCount.load() - allocsBefore;
+
+    const qint64 records = chunksPerPort * ports;
+    const qint64 wireBytes = records * chunkBytes;
+    const double wireNs = static_cast<double>(chunksPerPort) * chunkWireNs; // ports run in parallel
+
+    benchResult result;
+    result.name = name;
+    result.iterations = records;
+    result.bytesPerOp = chunkBytes;
+    result.nsPerOp = static_cast<double>(wallNs) / records;
+    result.nsPerByte = static_cast<double>(wallNs) / wireBytes;
+    result.allocsPerOp = allocationCountingAvailable() ? static_cast<double>(allocs) / records : -1.0;
+    result.extra["ports"] = ports;
+    result.extra["baudRate"] = baudRate;
+    result.extra["wireSecondsPerPort"] = wireNs / 1e9;
+    result.extra["cpuPercentOfOneCore"] = cpuNs * 100.0 / wireNs;
+    result.extra["diskBytesPerWireByte"] = static_cast<double>(QFileInfo(path).size()) / wireBytes;
+    return result;
+}
+
+template <typename Body>
+benchResult runBench(const QString &name, qint64 bytesPerOp, qint64 iterations, Body body)
+{
+    // warm up caches and first time allocations
+    for (qint64 i = 0; i < iterations / 10 + 1; ++i)
+        body();
+
+    qint64 allocsBefore = allocationCount.load();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (qint64 i = 0; i < iterations; ++i)
+        body();
+
+    qint64 ns = timer.nsecsElapsed();
+    qint64 allocs = allocationCount.load() - allocsBefore;
+
+    benchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.bytesPerOp = bytesPerOp;
+    result.nsPerOp = static_cast<double>(ns) / iterations;
+    result.nsPerByte = bytesPerOp > 0 ? result.nsPerOp / bytesPerOp : 0.0;
+    result.allocsPerOp = allocationCountingAvailable() ? static_cast<double>(allocs) / iterations : -1.0;
+    return result;
+}
+
+QByteArray ackFrame(quint8 value)
+{
+    QByteArray frame;
+    frame.append(0x41);
+    frame.append(0x43);
+    frame.append(0x4B);
+    frame.append(static_cast<char>(value));
+    frame.append(static_cast<char>(protocolUtils::calculateChecksum(frame)));
+    return frame;
+}
+
+QByteArray randomBytes(int size)
+{
+    QByteArray data(size, '\0');
+    for (int i = 0; i < size; ++i)
+        data[i] = static_cast<char>(QRandomGenerator::global()->bounded(256));
+    return data;
+}
+
+void discardMessages(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+}
+
+int main(int argc, char *argv[])
+{
+    installAllocationCounter();
+    QCoreApplication app(argc, argv);
+
+    QString jsonPath;
+    QString filter;
+    qint64 iterations = 100000;
+
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "--json" && i + 1 < args.size())
+            jsonPath = args[++i];
+        else if (args[i] == "--filter" && i + 1 < args.size())
+            filter = args[++i];
+        else if (args[i] == "--iterations" && i + 1 < args.size())
+            iterations = qMax<qint64>(1, args[++i].toLongLong());
+        else
+        {
+            fprintf(stderr, "usage: protocol_bench [--json file] [--filter name] [--iterations N]\n");
+            return 1;
+        }
+    }
+
+    // qDebug() text is still formatted, only the console write is skipped
+    qInstallMessageHandler(discardMessages);
+
+    QList<benchResult> results;
+    auto add = [&](const benchResult &result) {
+        if (filter.isEmpty() || result.name.contains(filter))
+            results << result;
+    };
+
+    serialPortHandler parser;
+    const QByteArray frame = ackFrame(0x5A);
+    const QByteArray block256 = randomBytes(256);
+    const QByteArray noise64 = randomBytes(64);
+    const QByteArray floatBytes = QByteArray::fromHex("3F800000");
+
+    //Frame parsing (readData path without the port), bytes per op = wire bytes
+    parser.recvMsgId(0x01);
+    add(runBench("parse_frame_whole", frame.size(), iterations, [&]() {
+        parser.processChunk(frame, 0, 0);
+    }));
+
+    // fragments built up front so only the parser's allocations are counted
+    QVector<QByteArray> fragments;
+    for (int i = 0; i < frame.size(); ++i)
+        fragments << frame.mid(i, 1);
+
+    parser.recvMsgId(0x01);
+    add(runBench("parse_frame_fragmented_1byte", frame.size(), iterations, [&]() {
+        for (const QByteArray &fragment : fragments)
+            parser.processChunk(fragment, 0, 0);
+    }));
+
+    parser.recvMsgId(0x01);
+    add(runBench("parse_noise_64", noise64.size(), iterations / 10, [&]() {
+        parser.processChunk(noise64, 0, 0);
+    }));
+
+    //Checksums
+    add(runBench("chkSum_5", frame.size(), iterations, [&]() {
+        sink += parser.chkSum(frame);
+    }));
+    add(runBench("chkSum_256", block256.size(), iterations, [&]() {
+        sink += parser.chkSum(block256);
+    }));
+    add(runBench("calculateChecksum_5", frame.size(), iterations, [&]() {
+        sink += protocolUtils::calculateChecksum(frame);
+    }));
+    add(runBench("calculateChecksum_256", block256.size(), iterations, [&]() {
+        sink += protocolUtils::calculateChecksum(block256);
+    }));
+
+    //Hex formatting
+    QByteArray hexFrame = frame;
+    QByteArray hexBlock = block256;
+    add(runBench("hexBytes_5", hexFrame.size(), iterations, [&]() {
+        sink += protocolUtils::hexBytes(hexFrame).size();
+    }));
+    add(runBench("hexBytes_256", hexBlock.size(), iterations / 10, [&]() {
+        sink += protocolUtils::hexBytes(hexBlock).size();
+    }));
+    add(runBench("hexBytesSerial_256", hexBlock.size(), iterations / 10, [&]() {
+        sink += parser.hexBytesSerial(hexBlock).size();
+    }));
+
+    //Float conversion
+    add(runBench("convertBytesToFloat", floatBytes.size(), iterations, [&]() {
+        sink += static_cast<quint32>(parser.convertBytesToFloat(floatBytes));
+    }));
+
+    //Logging path : one line per received frame, flushed like in the app
+    protocolUtils::initializeLogFile();
+    add(runBench("writeToNotes_frame", frame.size(), iterations / 100 + 1, [&]() {
+        protocolUtils::writeToNotes("Set User Value received bytes: "+frame.toHex());
+    }));
+    protocolUtils::closeLogFile();
+
+    //Recording : 4 ports at 921600 baud, readAll() chunks of 64 bytes (~0.7 ms of line time)
+    add(runRecorderBench("recorder_4x921600_chunk64", 4, 921600, 30, 64));
+
+    //Report
+    printf("%-32s %12s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "ns/byte", "allocs/op");
+    for (const benchResult &result : results)
+    {
+        printf("%-32s %12lld %12.1f %12.2f %12.2f\n", qPrintable(result.name),
+               static_cast<long long>(result.iterations), result.nsPerOp, result.nsPerByte, result.allocsPerOp);
+    }
+    for (const benchResult &result : results)
+    {
+        for (auto it = result.extra.constBegin(); it != result.extra.constEnd(); ++it)
+        {
+            printf("  %s %s = %.3f\n", qPrintable(result.name), qPrintable(it.key()), it.value().toDouble());
+        }
+    }
+
+    if (!jsonPath.isEmpty())
+    {
+        QJsonArray array;
+        for (const benchResult &result : results)
+        {
+            QJsonObject object;
+            object["name"] = result.name;
+            object["iterations"] = result.iterations;
+            object["bytesPerOp"] = result.bytesPerOp;
+            object["nsPerOp"] = result.nsPerOp;
+            object["nsPerByte"] = result.nsPerByte;
+            object["allocsPerOp"] = result.allocsPerOp;
+            for (auto it = result.extra.constBegin(); it != result.extra.constEnd(); ++it)
+                object[it.key()] = it.value();
+            array.append(object);
+        }
+
+        QJsonObject root;
+        root["benchmark"] = "protocol_bench";
+        root["qtVersion"] = qVersion();
+        root["allocationCounter"] = allocationCounter;
+        root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        root["results"] = array;
+
+        QFile file(jsonPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            fprintf(stderr, "Failed to open %s\n", qPrintable(jsonPath));
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+# Microbenchmarks for the protocol hot paths (frame parsing, checksum, hex, float, logging)
+# Build : qmake protocol_bench.pro && make   Run : protocol_bench [--json out.json]
+# No GUI sources : builds on Linux too, where allocations are counted on malloc
+# recorder_* case reports CPU % of one core and disk bytes per wire byte for multi port capture at line rate
+
+QT       += core serialport
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    protocol_bench.cpp \
+    ../protocolutils.cpp \
+    ../serialporthandler.cpp \
+    ../trafficrecorder.cpp
+
+HEADERS += \
+    ../monotonicclock.h \
+    ../protocolutils.h \
+    ../serialporthandler.h \
+    ../trafficrecorder.h
@@ -0,0 +1,109 @@
+#include "serialporthandler.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdlib>
+
+// Input layout : byte 0 selects msgId, then repeated [length byte][length % 32 + 1 bytes]
+// so one input is a random stream cut into random readyRead sized fragments.
+//
+// Checked per input :
+//   no crash / sanitizer report (libFuzzer + ASan/UBSan)
+//   receive buffer always shorter than one frame (serialPortHandler::FrameSize)
+//   time per byte below the wire time of one byte at 921600 baud (10 bits / 921600 = 10.85 us),
+//   a parser slower than the line falls behind whatever the chunk sizes are
+
+namespace
+{
+const qint64 MaxNsPerByte = 10000;     // < 10850 ns wire time per byte at 921600 baud
+const qint64 MinTimedBytes = 256;      // shorter inputs are timer and first call noise
+
+void discardMessages(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+serialPortHandler *fuzzParser()
+{
+    static int argc = 1;
+    static char name[] = "protocol_fuzz";
+    static char *argv[] = { name, nullptr };
+    static QCoreApplication app(argc, argv);
+    static serialPortHandler parser;
+    static bool initialized = false;
+
+    if (!initialized)
+    {
+        qInstallMessageHandler(discardMessages);
+        initialized = true;
+    }
+    return &parser;
+}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    serialPortHandler *parser = fuzzParser();
+
+    // msgId 0x01/0x02 are known commands, anything else takes the unknown path
+    parser->recvMsgId(data[0] % 4);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    size_t pos = 1;
+    qint64 fedBytes = 0;
+    while (pos < size)
+    {
+        size_t length = data[pos++] % 32 + 1;
+        length = qMin(length, size - pos);
+        if (length == 0)
+            break;
+
+        QByteArray chunk(reinterpret_cast<const char *>(data + pos), static_cast<int>(length));
+        parser->processChunk(chunk, 0, 0);
+        pos += length;
+        fedBytes += static_cast<qint64>(length);
+
+        if (parser->bufferedBytes() >= serialPortHandler::FrameSize)
+        {
+            fprintf(stderr, "receive buffer holds %d bytes after a chunk\n", parser->bufferedBytes());
+            abort();
+        }
+    }
+
+    if (fedBytes >= MinTimedBytes && timer.nsecsElapsed() / fedBytes > MaxNsPerByte)
+    {
+        fprintf(stderr, "%lld ns per byte over %lld bytes\n",
+                static_cast<long long>(timer.nsecsElapsed() / fedBytes), static_cast<long long>(fedBytes));
+        abort();
+    }
+
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+// Without libFuzzer : random inputs, protocol_fuzz [runs]
+#include <QRandomGenerator>
+
+int main(int argc, char *argv[])
+{
+    long runs = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 100000;
+
+    for (long run = 0; run < runs; ++run)
+    {
+        QByteArray input(QRandomGenerator::global()->bounded(1, 8192), '\0');
+        for (int i = 0; i < input.size(); ++i)
+            input[i] = static_cast<char>(QRandomGenerator::global()->bounded(256));
+
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.constData()),
+                               static_cast<size_t>(input.size()));
+    }
+
+    printf("%ld runs ok\n", runs);
+    return 0;
+}
+#endif
@@ -0,0 +1,32 @@
+# libFuzzer target for serialPortHandler frame parsing
+# Build (libFuzzer)  : qmake protocol_fuzz.pro && make   (compiles with clang++, libFuzzer is clang only)
+# Build (standalone) : qmake protocol_fuzz.pro CONFIG+=standalone && make   (random inputs, no libFuzzer)
+# Run                : protocol_fuzz corpus_dir
+
+QT       += core serialport
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+standalone {
+    DEFINES += FUZZ_STANDALONE
+} else {
+    QMAKE_CC = clang
+    QMAKE_CXX = clang++
+    QMAKE_LINK = clang++
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+}
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    protocol_fuzz.cpp \
+    ../serialporthandler.cpp
+
+HEADERS += \
+    ../monotonicclock.h \
+    ../serialporthandler.h
@@ -0,0 +1,250 @@
+#include "trafficrecorder.h"
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <cstdio>
+
+// Writes known records through trafficRecorder, then checks
+//   full file  : every chunk found and every record back in order
+//   truncated  : file cut at random bytes, all chunks before the cut come back intact
+//   corrupted  : one byte flipped inside a chunk, only that chunk is lost and
+//                scanChunks() resyncs on the following ones
+
+namespace
+{
+struct recordData
+{
+    qint64 timestampNs;
+    quint8 channel;
+    quint8 direction;
+    QByteArray data;
+
+    bool operator==(const recordData &other) const
+    {
+        return timestampNs == other.timestampNs && channel == other.channel
+                && direction == other.direction && data == other.data;
+    }
+};
+
+struct chunkInfo
+{
+    qint64 offset;
+    qint64 end;
+    int firstRecord;
+    int recordCount;
+};
+
+bool decodeRecords(const QByteArray &raw, QVector<recordData> *records)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(raw.constData());
+    int pos = 0;
+
+    while (pos < raw.size())
+    {
+        if (pos + 12 > raw.size())
+            return false;
+
+        recordData record;
+        record.timestampNs = qFromLittleEndian<qint64>(p + pos);
+        record.channel = p[pos + 8];
+        record.direction = p[pos + 9];
+        int length = qFromLittleEndian<quint16>(p + pos + 10);
+        pos += 12;
+
+        if (pos + length > raw.size())
+            return false;
+
+        record.data = raw.mid(pos, length);
+        pos += length;
+        records->append(record);
+    }
+    return true;
+}
+
+bool fail(const char *message, qint64 value = 0)
+{
+    fprintf(stderr, "FAILED: %s (%lld)\n", message, static_cast<long long>(value));
+    return false;
+}
+
+int failExit(const char *message, qint64 value = 0)
+{
+    fail(message, value);
+    return 1;
+}
+
+// Chunks at offsets must be exactly expectedSequences, read back and match the original records
+bool checkChunks(QFile &file, const QVector<qint64> &offsets, const QVector<chunkInfo> &chunks,
+                 const QVector<recordData> &expected, const QVector<int> &expectedSequences)
+{
+    if (offsets.size() != expectedSequences.size())
+        return fail("recovered chunk count", offsets.size());
+
+    for (int i = 0; i < offsets.size(); ++i)
+    {
+        trafficRecorder::ChunkHeader header;
+        QByteArray raw;
+        if (!trafficRecorder::readChunkAt(file, offsets[i], &header, &raw))
+            return fail("readChunkAt on recovered chunk", offsets[i]);
+
+        const chunkInfo &info = chunks[expectedSequences[i]];
+        if (static_cast<int>(header.sequence) != expectedSequences[i] || offsets[i] != info.offset)
+            return fail("unexpected chunk recovered", header.sequence);
+
+        QVector<recordData> records;
+        if (!decodeRecords(raw, &records) || records.size() != info.recordCount)
+            return fail("record count in chunk", header.sequence);
+
+        for (int r = 0; r < records.size(); ++r)
+        {
+            if (!(records[r] == expected[info.firstRecord + r]))
+                return fail("record content", info.firstRecord + r);
+        }
+    }
+    return true;
+}
+
+bool checkRecovered(QFile &file, const QVector<chunkInfo> &chunks, const QVector<recordData> &expected,
+                    const QVector<int> &expectedSequences)
+{
+    return checkChunks(file, trafficRecorder::scanChunks(file), chunks, expected, expectedSequences);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int cuts = argc > 1 ? QString(argv[1]).toInt() : 200;
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        return failExit("temporary dir");
+
+    const QString path = dir.filePath("roundtrip.urec");
+    QRandomGenerator random(1234);
+
+    //Write
+    QVector<recordData> expected;
+    {
+        trafficRecorder recorder;
+        recorder.setChunkSize(1024);        // many small chunks
+        recorder.setMaxQueuedChunks(100000); // nothing may be dropped in this check
+        if (!recorder.startRecording(path))
+            return failExit("startRecording");
+
+        qint64 timestampNs = 1000;
+        for (int i = 0; i < 5000; ++i)
+        {
+            recordData record;
+            record.timestampNs = timestampNs;
+            record.channel = static_cast<quint8>(random.bounded(4));
+            record.direction = random.bounded(2) ? trafficRecorder::Tx : trafficRecorder::Rx;
+            record.data = QByteArray(random.bounded(1, 300), '\0');
+            for (int b = 0; b < record.data.size(); ++b)
+                record.data[b] = static_cast<char>(random.bounded(16)); // compressible like real traffic
+
+            recorder.record(record.channel, static_cast<trafficRecorder::Direction>(record.direction),
+                            record.data, record.timestampNs);
+            expected << record;
+            timestampNs += random.bounded(1, 100000);
+        }
+        recorder.stopRecording();
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return failExit("open recording");
+    const QByteArray original = file.readAll();
+
+    //Full file : chunk table for the later checks
+    QVector<chunkInfo> chunks;
+    QVector<int> allSequences;
+    int nextRecord = 0;
+    for (qint64 offset : trafficRecorder::scanChunks(file))
+    {
+        trafficRecorder::ChunkHeader header;
+        QByteArray raw;
+        QVector<recordData> records;
+        if (!trafficRecorder::readChunkAt(file, offset, &header, &raw) || !decodeRecords(raw, &records))
+            return failExit("read full file chunk", offset);
+
+        chunks << chunkInfo{ offset, offset + trafficRecorder::ChunkHeaderSize + header.compressedSize,
+                             nextRecord, records.size() };
+        allSequences << static_cast<int>(header.sequence);
+        nextRecord += records.size();
+    }
+
+    if (nextRecord != expected.size() || chunks.size() < 2)
+        return failExit("full file records", nextRecord);
+    if (!checkRecovered(file, chunks, expected, allSequences))
+        return 1;
+    file.close();
+
+    QString damagedPath = dir.filePath("damaged.urec");
+    auto writeDamaged = [&](const QByteArray &content) {
+        QFile damaged(damagedPath);
+        return damaged.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                && damaged.write(content) == content.size();
+    };
+
+    //Truncated at random bytes (crash while writing)
+    for (int i = 0; i < cuts; ++i)
+    {
+        int cut = random.bounded(trafficRecorder::FileHeaderSize, original.size());
+        QVector<int> sequences;
+        for (int c = 0; c < chunks.size(); ++c)
+        {
+            if (chunks[c].end <= cut)
+                sequences << c;
+        }
+
+        QFile damaged(damagedPath);
+        if (!writeDamaged(original.left(cut)) || !damaged.open(QIODevice::ReadOnly))
+            return failExit("write truncated copy");
+        if (!checkRecovered(damaged, chunks, expected, sequences))
+        {
+            fprintf(stderr, "cut at byte %d of %d\n", cut, original.size());
+            return 1;
+        }
+    }
+
+    //One byte flipped inside a chunk payload
+    for (int i = 0; i < cuts; ++i)
+    {
+        int victim = random.bounded(chunks.size());
+        int position = random.bounded(static_cast<int>(chunks[victim].offset) + trafficRecorder::ChunkHeaderSize,
+                                      static_cast<int>(chunks[victim].end));
+        QByteArray content = original;
+        content[position] = static_cast<char>(content[position] ^ 0x5A);
+
+        QVector<int> sequences = allSequences;
+        sequences.removeAll(victim);
+
+        QFile damaged(damagedPath);
+        if (!writeDamaged(content) || !damaged.open(QIODevice::ReadOnly))
+            return failExit("write corrupted copy");
+
+        // A corrupted payload still has a valid header : scan finds it, read must reject it
+        QVector<qint64> offsets = trafficRecorder::scanChunks(damaged);
+        trafficRecorder::ChunkHeader header;
+        QByteArray raw;
+        if (!offsets.contains(chunks[victim].offset)
+                || trafficRecorder::readChunkAt(damaged, chunks[victim].offset, &header, &raw))
+        {
+            fprintf(stderr, "FAILED: corrupted chunk %d at byte %d not rejected\n", victim, position);
+            return 1;
+        }
+        offsets.removeAll(chunks[victim].offset);
+        if (!checkChunks(damaged, offsets, chunks, expected, sequences))
+        {
+            fprintf(stderr, "byte %d flipped in chunk %d\n", position, victim);
+            return 1;
+        }
+    }
+
+    printf("recorder round trip ok : %d records, %d chunks, %d bytes, %d cuts\n",
+           expected.size(), chunks.size(), original.size(), cuts);
+    return 0;
+}
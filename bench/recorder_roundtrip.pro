@@ -0,0 +1,19 @@
+# Round trip and crash recovery check for trafficRecorder (scanChunks / readChunkAt)
+# Build : qmake recorder_roundtrip.pro && make   Run : recorder_roundtrip [cuts]   (exit code 0 = ok)
+
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    recorder_roundtrip.cpp \
+    ../trafficrecorder.cpp
+
+HEADERS += \
+    ../trafficrecorder.h
@@ -1,9 +1,6 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
-QFile MainWindow::logFile;
-QTextStream MainWindow::logStream;
-
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
@@ -14,7 +11,17 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(ui->pushButton_clear,&QPushButton::clicked,ui->textEdit_rawBytes,&QTextEdit::clear);
 
-    ui->comboBox_ports->addItems(serialObj->availablePorts());
+    //Port list comes from background hotplug monitor, no enumeration on GUI thread
+    monitor = new portMonitor(this);
+    connect(monitor,&portMonitor::portsChanged,this,&MainWindow::onPortsChanged);
+    connect(monitor,&portMonitor::portArrived,this,&MainWindow::onPortArrived);
+    connect(monitor,&portMonitor::portRemoved,this,&MainWindow::onPortRemoved);
+    connect(serialObj,&serialPortHandler::portLost,this,&MainWindow::onPortLost);
+    monitor->start(QThread::LowPriority);
+
+    reopenTimer = new QTimer(this);
+    reopenTimer->setSingleShot(true);
+    connect(reopenTimer,&QTimer::timeout,this,&MainWindow::tryReopenSession);
 
     connect(ui->pushButton_portsRefresh,&QPushButton::clicked,this,&MainWindow::refreshPorts);
 
@@ -32,6 +39,18 @@ MainWindow::MainWindow(QWidget *parent)
     //gui display signal
     connect(serialObj,&serialPortHandler::guiDisplay,this,&MainWindow::showGuiData);
 
+    //traffic recorder, idle until Record button is pressed
+    recorder = new trafficRecorder(this);
+    connect(recorder,&trafficRecorder::recordingStatus,this,&MainWindow::recordingStatus);
+    connect(serialObj,&serialPortHandler::rawTraffic,recorder,
+            [this](quint8 direction, const QByteArray &data, qint64 timestampNs) {
+        recorder->record(0, static_cast<trafficRecorder::Direction>(direction), data, timestampNs); // channel 0 : only one port
+    });
+
+    //timing analysis view (non-modal)
+    timingView = new timingAnalysis(this);
+    connect(serialObj,&serialPortHandler::frameTimed,timingView,&timingAnalysis::addFrame);
+
     //reset previous notes #Notes things : Logging file
     resetLogFile();
     writeToNotes(+"    ******    "+QCoreApplication::applicationName() +
@@ -41,11 +60,15 @@ MainWindow::MainWindow(QWidget *parent)
     //Response Timer *********************************************##############
     responseTimer = new QTimer(this);
     responseTimer->setSingleShot(true); // Ensure it fires only once per use
+    responseTimer->setTimerType(Qt::PreciseTimer); // timeouts can be tens of ms
+
+    loadTimeoutSettings();
 
     // Connect the timer's timeout signal to a slot that handles the timeout
     connect(responseTimer, &QTimer::timeout, this, &MainWindow::handleTimeout);
 
     connect(serialObj, &serialPortHandler::dataReceived, this, &MainWindow::onDataReceived);
+    connect(serialObj, &serialPortHandler::frameTimed, this, &MainWindow::onFrameReceived);
     //************************************************************##############
 
     writeToNotes("Pointer Size: "+QString::number(sizeof(void *))+" If it is 8 : 64 bit else 4 means 32 bit");
@@ -56,117 +79,305 @@ MainWindow::~MainWindow()
 {
     writeToNotes(+"    ******    "+QCoreApplication::applicationName() +
                  "     Application Closed");
+    monitor->stopMonitor();
+    recorder->stopRecording();
     delete ui;
     delete serialObj;
     delete responseTimer;
     closeLogFile();
 }
 
-void MainWindow::initializeLogFile() {
-    if (!logFile.isOpen()) {
-        logFile.setFileName("debug_notes.txt");
-        if (!logFile.open(QIODevice::Append | QIODevice::Text)) {
-            qCritical() << "Failed to open log file.";
-        } else {
-            logStream.setDevice(&logFile);
-        }
+void MainWindow::refreshPorts()
+{
+    qDebug()<<"Refreshing ports...";
+
+    // Cached list right away, monitor re-enumerates in background and emits portsChanged()
+    onPortsChanged(monitor->ports());
+    monitor->requestRescan();
+}
+
+void MainWindow::onPortSelected(const QString &portName)
+{
+    reopenTimer->stop();
+    serialObj->setPORTNAME(portName);
+
+    sessionActive = monitor->findByPortName(portName, &sessionPort);
+    sessionLost = false;
+}
+
+void MainWindow::onPortsChanged(const QList<portIdentity> &ports)
+{
+    QString currentPort = ui->comboBox_ports->currentText();
+
+    ui->comboBox_ports->clear();
+    for (const portIdentity &port : ports)
+    {
+        ui->comboBox_ports->addItem(port.portName);
+        ui->comboBox_ports->setItemData(ui->comboBox_ports->count() - 1, port.description, Qt::ToolTipRole);
     }
+
+    ui->comboBox_ports->setCurrentText(currentPort);
 }
 
-void MainWindow::resetLogFile() {
-    // Close the log file if it is open
-    if (logFile.isOpen()) {
-        logStream.flush();
-        logFile.close();
+void MainWindow::onPortArrived(const portIdentity &port)
+{
+    if (!sessionActive || !sessionLost || port.key() != sessionPort.key())
+        return;
+
+    // Same device is back : reopen with the saved configuration
+    if (serialObj->reopenPort(port.portName))
+    {
+        sessionPort = port;
+        sessionLost = false;
+        reopenTimer->stop();
+        ui->comboBox_ports->setCurrentText(port.portName);
+        ui->statusbar->showMessage("Device back on "+port.portName+", session restored", 5000);
     }
+}
 
-    // Check if the file exists and delete it
-    QFile::remove("debug_notes.txt");
+void MainWindow::onPortRemoved(const portIdentity &port)
+{
+    if (!sessionActive || port.key() != sessionPort.key())
+        return;
 
-    // Reinitialize the log file
-    initializeLogFile();
+    // QSerialPort may not report an error until next read/write
+    onPortLost(port.portName);
 }
 
+void MainWindow::onPortLost(const QString &portName)
+{
+    if (sessionLost)
+        return;
+
+    sessionLost = true;
+
+    // Device is gone : no more writes on a dead handle (timeouts see a closed port)
+    serialObj->closePort();
 
-void MainWindow::writeToNotes(const QString &data) {
-    if (!logFile.isOpen()) {
-        qCritical() << "Log file is not open.";
+    QString text = "Port "+portName+" lost, waiting for the device to come back";
+    ui->statusbar->showMessage(text);
+    ui->textEdit_rawBytes->append(text);
+    writeToNotes(text);
+
+    // Quick replug can fall inside one rescan and produce no arrival event : keep trying
+    reopenDelayMs = 250;
+    reopenTimer->start(reopenDelayMs);
+}
+
+void MainWindow::tryReopenSession()
+{
+    if (!sessionActive || !sessionLost)
         return;
+
+    // Same device (by VID/PID/serial) in the cache, possibly under a new name
+    portIdentity port;
+    if (monitor->findByKey(sessionPort.key(), &port))
+    {
+        onPortArrived(port);
     }
 
-    // Add a timestamp for each entry
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz");
-    logStream << "[" << timestamp << "] " << data << Qt::endl;
-    logStream.flush(); // Ensure immediate write to disk
+    if (sessionLost)
+    {
+        // Device node may not be ready yet : rescan and retry with backoff (max 5 s)
+        monitor->requestRescan();
+        reopenDelayMs = qMin(reopenDelayMs * 2, 5000);
+        reopenTimer->start(reopenDelayMs);
+    }
 }
 
-void MainWindow::closeLogFile() {
-    if (logFile.isOpen()) {
-        logStream.flush();
-        logFile.close();
-    }
+void MainWindow::loadTimeoutSettings()
+{
+    QSettings settings("settings.ini", QSettings::IniFormat);
+
+    minTimeoutMs     = qMax(1, settings.value("Timeout/minMs", minTimeoutMs).toInt());
+    maxTimeoutMs     = qMax(minTimeoutMs, settings.value("Timeout/maxMs", maxTimeoutMs).toInt());
+    initialTimeoutMs = qBound(minTimeoutMs, settings.value("Timeout/initialMs", initialTimeoutMs).toInt(), maxTimeoutMs);
+    maxRetries       = qMax(0, settings.value("Timeout/retries", maxRetries).toInt());
+    fastFail         = settings.value("Timeout/fastFail", fastFail).toBool();
+
+    writeToNotes("Timeout policy min: "+QString::number(minTimeoutMs)+" ms max: "
+                 +QString::number(maxTimeoutMs)+" ms initial: "+QString::number(initialTimeoutMs)
+                 +" ms retries: "+QString::number(maxRetries)
+                 +" fastFail: "+QString(fastFail ? "on" : "off"));
+}
+
+int MainWindow::responseTimeoutFor(quint8 msgId) const
+{
+    RttEstimate est = rttTable.value(msgId);
+
+    // No sample yet for this command : start from initialTimeoutMs
+    double rto = initialTimeoutMs;
+
+    // RFC 6298 : RTO = SRTT + max(G, 4 * RTTVAR), G = 1 ms timer granularity
+    if (est.valid)
+        rto = est.srtt + qMax(1.0, 4.0 * est.rttvar);
+
+    // Answer needed a retry or came late : keep the backed off value until a clean sample
+    rto = qMax(rto, static_cast<double>(est.backoffMs));
+
+    return qBound(minTimeoutMs, static_cast<int>(std::ceil(rto)), maxTimeoutMs);
 }
 
-quint8 MainWindow::calculateChecksum(const QByteArray &data)
+void MainWindow::updateRtt(quint8 msgId, double sampleMs)
 {
-    quint8 checkSum = 0;
-    for(quint8 byte : data)
+    RttEstimate &est = rttTable[msgId];
+
+    if (!est.valid)
     {
-        checkSum ^= byte;
+        est.srtt = sampleMs;
+        est.rttvar = sampleMs / 2.0;
+        est.valid = true;
     }
-
-    return checkSum;
+    else
+    {
+        // alpha = 1/8, beta = 1/4 (same gains as TCP)
+        est.rttvar = 0.75 * est.rttvar + 0.25 * std::fabs(est.srtt - sampleMs);
+        est.srtt   = 0.875 * est.srtt + 0.125 * sampleMs;
+    }
+    est.backoffMs = 0;
 }
 
-void MainWindow::refreshPorts()
+void MainWindow::sendCommand(const QByteArray &command, quint8 msgId)
 {
-    QString currentPort = ui->comboBox_ports->currentText();
+    // A new command replaces whatever was still waiting
+    responseTimer->stop();
+    pendingCommand.clear();
+    lateAnswerPossible = false;
 
-    qDebug()<<"Refreshing ports...";
-    ui->comboBox_ports->clear();
-    QStringList availablePorts;
-    ui->comboBox_ports->addItems(serialObj->availablePorts());
+    emit sendMsgId(msgId);
 
-    ui->comboBox_ports->setCurrentText(currentPort);
+    if (!serialObj->isPortOpen())
+    {
+        // writeData() reports the port error itself, nothing to wait for
+        serialObj->writeData(command);
+        return;
+    }
+
+    pendingCommand = command;
+    pendingMsgId = msgId;
+    pendingRetries = 0;
+    currentTimeoutMs = responseTimeoutFor(msgId);
+
+    rttTimer.start();
+    serialObj->writeData(command);
+    responseTimer->start(currentTimeoutMs);
 }
 
-void MainWindow::onPortSelected(const QString &portName)
+void MainWindow::reportTimeoutStatus(const QString &text)
 {
-    serialObj->setPORTNAME(portName);
+    // Non-modal : status bar + log, never blocks the event loop
+    ui->statusbar->showMessage(text, 5000);
+    ui->textEdit_rawBytes->append(text);
+    writeToNotes(text);
 }
 
 void MainWindow::handleTimeout()
 {
-    QMessageBox::warning(this, "Timeout", "Hardware Not Responding!");
+    if (pendingCommand.isEmpty())
+    {
+        // Timer started directly without sendCommand(), nothing to resend
+        reportTimeoutStatus("Timeout : Hardware Not Responding!");
+        return;
+    }
+
+    if (!serialObj->isPortOpen())
+    {
+        // Port closed meanwhile (unplug) : writeData() would fake a response
+        reportTimeoutStatus("Timeout msgId 0x"+QString::number(pendingMsgId, 16)
+                            +" : port closed, command not retried");
+        pendingCommand.clear();
+        return;
+    }
+
+    bool deviceDead = fastFail && consecutiveTimeouts > 0;
+
+    if (!deviceDead && pendingRetries < maxRetries)
+    {
+        // Exponential backoff, retransmitted command is not used for RTT (Karn)
+        pendingRetries++;
+        currentTimeoutMs = qMin(currentTimeoutMs * 2, maxTimeoutMs);
+
+        reportTimeoutStatus("Timeout msgId 0x"+QString::number(pendingMsgId, 16)
+                            +" retry "+QString::number(pendingRetries)+"/"+QString::number(maxRetries)
+                            +" waiting "+QString::number(currentTimeoutMs)+" ms");
+
+        emit sendMsgId(pendingMsgId);
+        serialObj->writeData(pendingCommand);
+        responseTimer->start(currentTimeoutMs);
+        return;
+    }
+
+    consecutiveTimeouts++;
+
+    reportTimeoutStatus("Timeout msgId 0x"+QString::number(pendingMsgId, 16)
+                        +" : Hardware Not Responding! (after "+QString::number(rttTimer.elapsed())+" ms)");
+
+    // An answer may still come : it must not be lost as a health signal
+    lateAnswerPossible = true;
+    failedMsgId = pendingMsgId;
+    failedTimeoutMs = currentTimeoutMs;
+
+    pendingCommand.clear();
 }
 
 void MainWindow::onDataReceived()
 {
-    // Stop the timer since data has been received
-    qDebug()<<"Hello stop it";
-    if (responseTimer->isActive()) {
+    // writeData() on a closed port emits dataReceived() too, that is not an answer
+    if (!serialObj->isPortOpen())
+    {
+        if (pendingCommand.isEmpty() && responseTimer->isActive())
+            responseTimer->stop();
+        return;
+    }
+
+    // Raw bytes (maybe garbage or a cut-off reply) only prove the device is alive,
+    // the answer itself is taken in onFrameReceived()
+    if (consecutiveTimeouts > 0)
+    {
+        ui->statusbar->showMessage("Hardware responding again", 3000);
+        consecutiveTimeouts = 0;
+    }
+
+    // Timer started directly without sendCommand() : old behaviour, any data stops it
+    if (pendingCommand.isEmpty() && responseTimer->isActive())
+    {
         responseTimer->stop();
     }
 }
 
-
-//The below function is intended for providing space between hex bytes
-QString MainWindow::hexBytes(QByteArray &cmd)
+void MainWindow::onFrameReceived(const serialFrame &frame)
 {
-    //**************************Visuals*******************
-    QString hexOutput = cmd.toHex().toUpper();
-    QString formattedHexOutput;
-
-    for (int i = 0; i < hexOutput.size(); i += 2) {
-        if (i > 0) {
-            formattedHexOutput += " ";
+    if (pendingCommand.isEmpty() || frame.msgId != pendingMsgId)
+    {
+        if (lateAnswerPossible && frame.msgId == failedMsgId)
+        {
+            // Timeout was too short for this command : back off for the next send
+            RttEstimate &est = rttTable[failedMsgId];
+            est.backoffMs = qMin(maxTimeoutMs, qMax(est.backoffMs, failedTimeoutMs * 2));
+            lateAnswerPossible = false;
         }
-        formattedHexOutput += hexOutput.mid(i, 2);
+        return;
+    }
+
+    // Validated answer for the pending command
+    responseTimer->stop();
+
+    if (pendingRetries == 0)
+    {
+        // Only first try gives an unambiguous sample
+        updateRtt(pendingMsgId, rttTimer.nsecsElapsed() / 1000000.0);
+    }
+    else
+    {
+        // Retry was needed : keep its timeout until a clean sample arrives
+        RttEstimate &est = rttTable[pendingMsgId];
+        est.backoffMs = qMax(est.backoffMs, currentTimeoutMs);
     }
-    return formattedHexOutput;
-    //**************************Visuals*******************
+
+    pendingCommand.clear();
 }
 
+
 void MainWindow::printMemoryUsage()
 {
     PROCESS_MEMORY_COUNTERS_EX memInfo;
@@ -246,7 +457,7 @@ void MainWindow::portStatus(const QString &data)
         QMessageBox::critical(this,"Port Error","Please Select Port Using Above Dropdown");
     }
 
-    if(data.startsWith("Serial port ") && data.endsWith(" opened successfully at baud rate 921600"))
+    if(data.startsWith("Serial port ") && data.contains(" opened successfully at baud rate "))
     {
         QMessageBox::information(this,"Success",data);
     }
@@ -300,3 +511,39 @@ void MainWindow::on_pushButton_calibrateScreen_clicked()
     QMessageBox::information(this, "Calibration Done",
                              QString("DPI set to %1.\nRestart app to apply.").arg(ppi));
 }
+
+void MainWindow::on_pushButton_record_toggled(bool checked)
+{
+    if (checked)
+    {
+        QString fileName = "traffic_"+QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss")+".urec";
+        if (!recorder->startRecording(fileName))
+        {
+            ui->pushButton_record->setChecked(false);
+        }
+    }
+    else
+    {
+        recorder->stopRecording();
+    }
+}
+
+void MainWindow::on_pushButton_timing_clicked()
+{
+    timingView->show();
+    timingView->raise();
+    timingView->activateWindow();
+}
+
+void MainWindow::recordingStatus(const QString &status)
+{
+    ui->statusbar->showMessage(status, 5000);
+    ui->textEdit_rawBytes->append(status);
+    writeToNotes(status);
+
+    // Recorder stopped by itself (write error) : release the button, this closes the file
+    if (!recorder->isRecording() && ui->pushButton_record->isChecked())
+    {
+        ui->pushButton_record->setChecked(false);
+    }
+}
@@ -5,6 +5,10 @@
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <serialporthandler.h>
+#include "protocolutils.h"
+#include "timinganalysis.h"
+#include "portmonitor.h"
+#include "trafficrecorder.h"
 #include <QMessageBox>
 #include <QFile>
 #include <QDateTime>
@@ -20,6 +24,8 @@
 #include <QLabel>
 #include <QScreen>
 #include <QInputDialog>
+#include <QSettings>
+#include <QHash>
 
 
 
@@ -42,13 +48,18 @@ public:
     void refreshPorts();
 
     //For Saving log Data
-    void resetLogFile();
-    static void writeToNotes(const QString &data);
-    void initializeLogFile();
-    void closeLogFile();
+    void resetLogFile() { protocolUtils::resetLogFile(); }
+    static void writeToNotes(const QString &data) { protocolUtils::writeToNotes(data); }
+    static void initializeLogFile() { protocolUtils::initializeLogFile(); }
+    static void closeLogFile() { protocolUtils::closeLogFile(); }
 
-    quint8 calculateChecksum(const QByteArray &data);
-    QString hexBytes(QByteArray &cmd);
+    static quint8 calculateChecksum(const QByteArray &data) { return protocolUtils::calculateChecksum(data); }
+    static QString hexBytes(QByteArray &cmd) { return protocolUtils::hexBytes(cmd); }
+
+    //Adaptive response timeout (RTT per msgId, TCP RTO style)
+    void sendCommand(const QByteArray &command, quint8 msgId);
+    int responseTimeoutFor(quint8 msgId) const;
+    void loadTimeoutSettings();
 
     //Extra features
     void printMemoryUsage();
@@ -68,6 +79,13 @@ public:
 private slots:
         void onPortSelected(const QString &portName);
 
+        //hotplug handling
+        void onPortsChanged(const QList<portIdentity> &ports);
+        void onPortArrived(const portIdentity &port);
+        void onPortRemoved(const portIdentity &port);
+        void onPortLost(const QString &portName);
+        void tryReopenSession();
+
         void portStatus(const QString&);
 
         void showGuiData(const QByteArray &byteArrayData);
@@ -78,8 +96,16 @@ private slots:
 
         void onDataReceived();
 
+        void onFrameReceived(const serialFrame &frame);
+
         void on_pushButton_calibrateScreen_clicked();
 
+        void on_pushButton_record_toggled(bool checked);
+
+        void on_pushButton_timing_clicked();
+
+        void recordingStatus(const QString &status);
+
 signals:
     void sendMsgId(quint8 id);
 
@@ -87,15 +113,56 @@ private:
     Ui::MainWindow *ui;
     serialPortHandler *serialObj;
 
-    //Log handling
-    static QFile logFile;
-    static QTextStream logStream;
+    //Hotplug monitor (cached port list) and session to restore after replug
+    portMonitor *monitor = nullptr;
+    portIdentity sessionPort;
+    bool sessionActive = false;
+    bool sessionLost = false;
+    QTimer *reopenTimer = nullptr; // retries reopen with backoff while sessionLost
+    int reopenDelayMs = 0;
 
     //Response Time waiting timer
      QTimer *responseTimer = nullptr; // Timer to track response timeout
 
+    //Round trip time statistics per msgId (values in ms)
+     struct RttEstimate
+     {
+         double srtt = 0.0;   // smoothed round trip time
+         double rttvar = 0.0; // round trip time variation
+         bool valid = false;  // false until first sample is taken
+         int backoffMs = 0;   // kept after an answer needed a retry or came late (Karn)
+     };
+     QHash<quint8, RttEstimate> rttTable;
+
+     void updateRtt(quint8 msgId, double sampleMs);
+     void reportTimeoutStatus(const QString &text);
+
+    //Command waiting for response (used for retry)
+     QElapsedTimer rttTimer;
+     QByteArray pendingCommand;
+     quint8 pendingMsgId = 0x00;
+     int pendingRetries = 0;
+     int currentTimeoutMs = 0;
+     int consecutiveTimeouts = 0;
+     bool lateAnswerPossible = false; // last command failed, an answer may still arrive
+     quint8 failedMsgId = 0x00;
+     int failedTimeoutMs = 0;
+
+    //Timeout policy : settings.ini [Timeout] group
+     int minTimeoutMs = 20;    // lower bound of computed timeout
+     int maxTimeoutMs = 2000;  // upper bound of computed timeout
+     int initialTimeoutMs = 200; // used before first RTT sample of a msgId
+     int maxRetries = 1;       // resends before reporting failure
+     bool fastFail = true;     // after a failure no retries until device answers
+
     //Extras
      QElapsedTimer elapsedTimer;
 
+    //Compressed traffic recording (soak tests)
+     trafficRecorder *recorder = nullptr;
+
+    //Rx/Tx timing view, collects frames even while hidden
+     timingAnalysis *timingView = nullptr;
+
 };
 #endif // MAINWINDOW_H
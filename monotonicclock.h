@@ -0,0 +1,19 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+#include <chrono>
+
+// Monotonic nanosecond clock for Rx/Tx timestamps, frame timing and recordings.
+// Header only so the parser, timing view and bench/ targets need nothing else to link.
+class monotonicClock
+{
+public:
+    static qint64 nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // MONOTONICCLOCK_H
@@ -0,0 +1,282 @@
+#include "portmonitor.h"
+
+#include <QCoreApplication>
+
+#if defined(Q_OS_LINUX)
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <dbt.h>
+#endif
+
+QString portIdentity::key() const
+{
+    if (hasIds && !serialNumber.isEmpty())
+        return QString("%1:%2:%3").arg(vendorId, 4, 16, QChar('0')).arg(productId, 4, 16, QChar('0')).arg(serialNumber);
+
+    // No serial number : same adapter type on same port name is the best we can do
+    if (hasIds)
+        return QString("%1:%2@%3").arg(vendorId, 4, 16, QChar('0')).arg(productId, 4, 16, QChar('0')).arg(portName);
+
+    return systemLocation;
+}
+
+bool portIdentity::operator==(const portIdentity &other) const
+{
+    return portName == other.portName && key() == other.key();
+}
+
+portMonitor::portMonitor(QObject *parent) : QThread(parent)
+{
+    qRegisterMetaType<portIdentity>("portIdentity");
+    qRegisterMetaType<QList<portIdentity>>("QList<portIdentity>");
+
+    clock.start();
+
+#if defined(Q_OS_LINUX)
+    // Kernel uevents (group 1), no libudev dependency
+    netlinkSocket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (netlinkSocket >= 0)
+    {
+        sockaddr_nl address = {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = 1;
+
+        if (bind(netlinkSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            close(netlinkSocket);
+            netlinkSocket = -1;
+        }
+    }
+
+    if (netlinkSocket < 0)
+    {
+        qWarning() << "Hotplug netlink socket not available, falling back to polling";
+    }
+#endif
+
+    if (QCoreApplication::instance())
+    {
+        QCoreApplication::instance()->installNativeEventFilter(this);
+    }
+}
+
+portMonitor::~portMonitor()
+{
+    if (QCoreApplication::instance())
+    {
+        QCoreApplication::instance()->removeNativeEventFilter(this);
+    }
+
+    stopMonitor();
+
+#if defined(Q_OS_LINUX)
+    if (netlinkSocket >= 0)
+    {
+        close(netlinkSocket);
+    }
+#endif
+}
+
+QList<portIdentity> portMonitor::ports() const
+{
+    QMutexLocker locker(&cacheMutex);
+    return cache;
+}
+
+bool portMonitor::findByPortName(const QString &portName, portIdentity *identity) const
+{
+    QMutexLocker locker(&cacheMutex);
+    for (const portIdentity &port : cache)
+    {
+        if (port.portName == portName)
+        {
+            *identity = port;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool portMonitor::findByKey(const QString &key, portIdentity *identity) const
+{
+    QMutexLocker locker(&cacheMutex);
+    for (const portIdentity &port : cache)
+    {
+        if (port.key() == key)
+        {
+            *identity = port;
+            return true;
+        }
+    }
+    return false;
+}
+
+void portMonitor::requestRescan(int delayMs)
+{
+    QMutexLocker locker(&wakeMutex);
+
+    // Burst of events pushes the deadline out, one enumeration per burst
+    rescanPending = true;
+    rescanDeadlineMs = clock.elapsed() + delayMs;
+    wakeCondition.wakeAll();
+}
+
+void portMonitor::stopMonitor()
+{
+    if (!isRunning())
+        return;
+
+    requestInterruption();
+    {
+        QMutexLocker locker(&wakeMutex);
+        wakeCondition.wakeAll();
+    }
+    wait();
+}
+
+bool portMonitor::nativeEventFilter(const QByteArray &eventType, void *message, long *result)
+{
+    Q_UNUSED(result)
+
+#if defined(Q_OS_WIN)
+    if (eventType == "windows_generic_MSG")
+    {
+        MSG *msg = static_cast<MSG *>(message);
+        if (msg->message == WM_DEVICECHANGE
+                && (msg->wParam == DBT_DEVICEARRIVAL || msg->wParam == DBT_DEVICEREMOVECOMPLETE
+                    || msg->wParam == DBT_DEVNODES_CHANGED))
+        {
+            requestRescan(SettleDelayMs);
+        }
+    }
+#else
+    Q_UNUSED(eventType)
+    Q_UNUSED(message)
+#endif
+
+    return false; // never consume, only observe
+}
+
+void portMonitor::run()
+{
+    while (!isInterruptionRequested())
+    {
+        int timeoutMs;
+        bool due = false;
+        {
+            QMutexLocker locker(&wakeMutex);
+            if (rescanPending)
+            {
+                qint64 left = rescanDeadlineMs - clock.elapsed();
+                due = left <= 0;
+                timeoutMs = static_cast<int>(qMax<qint64>(0, left));
+            }
+            else
+            {
+                timeoutMs = -1;
+            }
+
+            if (due)
+                rescanPending = false;
+        }
+
+        if (due)
+        {
+            rescan();
+            continue;
+        }
+
+        waitForEvent(timeoutMs);
+    }
+}
+
+void portMonitor::waitForEvent(int timeoutMs)
+{
+#if defined(Q_OS_LINUX)
+    if (netlinkSocket >= 0)
+    {
+        // Short slices so requestRescan()/stopMonitor() are noticed quickly
+        pollfd fd = { netlinkSocket, POLLIN, 0 };
+        int slice = (timeoutMs < 0 || timeoutMs > 100) ? 100 : timeoutMs;
+
+        if (poll(&fd, 1, slice) > 0 && (fd.revents & POLLIN))
+        {
+            char message[8192];
+            ssize_t size = recv(netlinkSocket, message, sizeof(message), MSG_DONTWAIT);
+
+            // "ACTION@DEVPATH\0KEY=VALUE\0..." , only tty devices matter
+            if (size > 0 && QByteArray::fromRawData(message, static_cast<int>(size)).contains("SUBSYSTEM=tty"))
+            {
+                requestRescan(SettleDelayMs);
+            }
+        }
+        return;
+    }
+#endif
+
+    QMutexLocker locker(&wakeMutex);
+    if (isInterruptionRequested() || (rescanPending && timeoutMs == 0))
+        return;
+
+#if defined(Q_OS_WIN)
+    // WM_DEVICECHANGE wakes us, no polling needed
+    unsigned long waitMs = timeoutMs < 0 ? ULONG_MAX : static_cast<unsigned long>(timeoutMs);
+    wakeCondition.wait(&wakeMutex, waitMs);
+#else
+    // No event source : poll by re-enumerating in the background
+    unsigned long waitMs = static_cast<unsigned long>(timeoutMs);
+    if (timeoutMs < 0)
+        waitMs = PollIntervalMs; // used as a value only, no out-of-class definition needed (C++11)
+    if (!wakeCondition.wait(&wakeMutex, waitMs) && !rescanPending)
+    {
+        rescanPending = true;
+        rescanDeadlineMs = clock.elapsed();
+    }
+#endif
+}
+
+void portMonitor::rescan()
+{
+    QList<portIdentity> found;
+
+    foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    {
+        portIdentity port;
+        port.portName = info.portName();
+        port.systemLocation = info.systemLocation();
+        port.description = info.description();
+        port.serialNumber = info.serialNumber();
+        port.hasIds = info.hasVendorIdentifier() && info.hasProductIdentifier();
+        port.vendorId = info.vendorIdentifier();
+        port.productId = info.productIdentifier();
+        found << port;
+    }
+
+    QList<portIdentity> previous;
+    {
+        QMutexLocker locker(&cacheMutex);
+        previous = cache;
+        cache = found;
+    }
+
+    if (previous == found)
+        return;
+
+    for (const portIdentity &port : previous)
+    {
+        if (!found.contains(port))
+            emit portRemoved(port);
+    }
+
+    for (const portIdentity &port : found)
+    {
+        if (!previous.contains(port))
+            emit portArrived(port);
+    }
+
+    emit portsChanged(found);
+}
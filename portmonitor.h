@@ -0,0 +1,80 @@
+#ifndef PORTMONITOR_H
+#define PORTMONITOR_H
+
+#include <QThread>
+#include <QAbstractNativeEventFilter>
+#include <QSerialPortInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QList>
+#include <QDebug>
+
+// Serial port seen by portMonitor. key() stays the same when a board is replugged
+// even if it comes back under another port name (VID/PID/serial number).
+struct portIdentity
+{
+    QString portName;
+    QString systemLocation;
+    QString description;
+    QString serialNumber;
+    quint16 vendorId = 0;
+    quint16 productId = 0;
+    bool hasIds = false;
+
+    QString key() const;
+    bool operator==(const portIdentity &other) const;
+};
+
+Q_DECLARE_METATYPE(portIdentity)
+
+// Background hotplug monitor with a cached port list.
+// Linux   : kernel uevents on a NETLINK_KOBJECT_UEVENT socket
+// Windows : WM_DEVICECHANGE from the native event filter
+// other   : periodic re-enumeration
+// QSerialPortInfo::availablePorts() only runs on this thread, never on the GUI thread.
+class portMonitor : public QThread, public QAbstractNativeEventFilter
+{
+    Q_OBJECT
+public:
+    explicit portMonitor(QObject *parent = nullptr);
+    ~portMonitor();
+
+    QList<portIdentity> ports() const;  // cached, does not enumerate
+    bool findByPortName(const QString &portName, portIdentity *identity) const;
+    bool findByKey(const QString &key, portIdentity *identity) const;
+
+    void requestRescan(int delayMs = 0);
+    void stopMonitor();
+
+    bool nativeEventFilter(const QByteArray &eventType, void *message, long *result) override;
+
+signals:
+    void portsChanged(const QList<portIdentity> &ports);
+    void portArrived(const portIdentity &port);
+    void portRemoved(const portIdentity &port);
+
+protected:
+    void run() override;
+
+private:
+    void waitForEvent(int timeoutMs);
+    void rescan();
+
+    mutable QMutex cacheMutex;
+    QList<portIdentity> cache;
+
+    QMutex wakeMutex;
+    QWaitCondition wakeCondition;
+    bool rescanPending = true;  // first scan fills the cache
+    qint64 rescanDeadlineMs = 0;
+    QElapsedTimer clock;
+
+    int netlinkSocket = -1;
+
+    static constexpr int SettleDelayMs = 200; // device node shows up a bit after the uevent
+    static constexpr int PollIntervalMs = 2000;
+};
+
+#endif // PORTMONITOR_H
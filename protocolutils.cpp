@@ -0,0 +1,80 @@
+#include "protocolutils.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+QFile protocolUtils::logFile;
+QTextStream protocolUtils::logStream;
+
+void protocolUtils::initializeLogFile() {
+    if (!logFile.isOpen()) {
+        logFile.setFileName("debug_notes.txt");
+        if (!logFile.open(QIODevice::Append | QIODevice::Text)) {
+            qCritical() << "Failed to open log file.";
+        } else {
+            logStream.setDevice(&logFile);
+        }
+    }
+}
+
+void protocolUtils::resetLogFile() {
+    // Close the log file if it is open
+    if (logFile.isOpen()) {
+        logStream.flush();
+        logFile.close();
+    }
+
+    // Check if the file exists and delete it
+    QFile::remove("debug_notes.txt");
+
+    // Reinitialize the log file
+    initializeLogFile();
+}
+
+
+void protocolUtils::writeToNotes(const QString &data) {
+    if (!logFile.isOpen()) {
+        qCritical() << "Log file is not open.";
+        return;
+    }
+
+    // Add a timestamp for each entry
+    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz");
+    logStream << "[" << timestamp << "] " << data << Qt::endl;
+    logStream.flush(); // Ensure immediate write to disk
+}
+
+void protocolUtils::closeLogFile() {
+    if (logFile.isOpen()) {
+        logStream.flush();
+        logFile.close();
+    }
+}
+
+quint8 protocolUtils::calculateChecksum(const QByteArray &data)
+{
+    quint8 checkSum = 0;
+    for(quint8 byte : data)
+    {
+        checkSum ^= byte;
+    }
+
+    return checkSum;
+}
+
+//The below function is intended for providing space between hex bytes
+QString protocolUtils::hexBytes(QByteArray &cmd)
+{
+    //**************************Visuals*******************
+    QString hexOutput = cmd.toHex().toUpper();
+    QString formattedHexOutput;
+
+    for (int i = 0; i < hexOutput.size(); i += 2) {
+        if (i > 0) {
+            formattedHexOutput += " ";
+        }
+        formattedHexOutput += hexOutput.mid(i, 2);
+    }
+    return formattedHexOutput;
+    //**************************Visuals*******************
+}
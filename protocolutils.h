@@ -0,0 +1,28 @@
+#ifndef PROTOCOLUTILS_H
+#define PROTOCOLUTILS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QFile>
+#include <QTextStream>
+
+// Protocol helpers and notes logging without any GUI dependency.
+// MainWindow forwards to these, bench/ links them without the app.
+class protocolUtils
+{
+public:
+    //For Saving log Data (debug_notes.txt)
+    static void initializeLogFile();
+    static void resetLogFile();
+    static void writeToNotes(const QString &data);
+    static void closeLogFile();
+
+    static quint8 calculateChecksum(const QByteArray &data);
+    static QString hexBytes(QByteArray &cmd);
+
+private:
+    static QFile logFile;
+    static QTextStream logStream;
+};
+
+#endif // PROTOCOLUTILS_H
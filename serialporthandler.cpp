@@ -4,6 +4,8 @@ serialPortHandler::serialPortHandler(QObject *parent) : QObject(parent)
 {
     serial = new QSerialPort;
     connect(serial, &QSerialPort::readyRead, this, &serialPortHandler::readData);
+    connect(serial, &QSerialPort::errorOccurred, this, &serialPortHandler::handleError);
+    connect(serial, &QSerialPort::bytesWritten, this, &serialPortHandler::onBytesWritten);
 
 }
 
@@ -23,6 +25,35 @@ QStringList serialPortHandler::availablePorts()
 }
 
 void serialPortHandler::setPORTNAME(const QString &portName)
+{
+    if(!openPort(portName))
+    {
+        qDebug()<<"Failed to open port"<<serial->portName();
+        emit portOpening("Failed to open port "+serial->portName());
+    }
+    else
+    {
+        qDebug() << "Serial port "<<serial->portName()<<" opened successfully at baud rate "<<config.baudRate;
+        emit portOpening("Serial port "+serial->portName()+" opened successfully at baud rate "
+                         +QString::number(config.baudRate));
+    }
+}
+
+bool serialPortHandler::reopenPort(const QString &portName)
+{
+    if(!openPort(portName))
+    {
+        qDebug()<<"Failed to reopen port"<<portName;
+        emit executeWriteToNotes("Failed to reopen port "+portName);
+        return false;
+    }
+
+    qDebug() << "Serial port "<<portName<<" reopened after replug";
+    emit portOpening("Serial port "+portName+" reopened after replug");
+    return true;
+}
+
+bool serialPortHandler::openPort(const QString &portName)
 {
     buffer.clear();
 
@@ -32,23 +63,40 @@ void serialPortHandler::setPORTNAME(const QString &portName)
     }
 
     serial->setPortName(portName);
-    serial->setBaudRate(921600);
-    serial->setDataBits(QSerialPort::Data8);
-    serial->setParity(QSerialPort::NoParity);
-    serial->setStopBits(QSerialPort::OneStop);
-    serial->setFlowControl(QSerialPort::NoFlowControl);
+    serial->setBaudRate(config.baudRate);
+    serial->setDataBits(config.dataBits);
+    serial->setParity(config.parity);
+    serial->setStopBits(config.stopBits);
+    serial->setFlowControl(config.flowControl);
 
+    return serial->open(QIODevice::ReadWrite);
+}
 
-    if(!serial->open(QIODevice::ReadWrite))
+void serialPortHandler::closePort()
+{
+    if(serial->isOpen())
     {
-        qDebug()<<"Failed to open port"<<serial->portName();
-        emit portOpening("Failed to open port "+serial->portName());
+        serial->close();
     }
-    else
+    buffer.clear();
+}
+
+void serialPortHandler::handleError(QSerialPort::SerialPortError error)
+{
+    // ResourceError : device disappeared (USB unplug), port is unusable
+    if(error != QSerialPort::ResourceError || !serial->isOpen())
     {
-        qDebug() << "Serial port "<<serial->portName()<<" opened successfully at baud rate 921600";
-        emit portOpening("Serial port "+serial->portName()+" opened successfully at baud rate 921600");
+        return;
     }
+
+    QString portName = serial->portName();
+    qDebug() << "Serial port "<<portName<<" lost:"<<serial->errorString();
+
+    serial->close();
+    buffer.clear();
+
+    emit executeWriteToNotes("Serial port "+portName+" lost: "+serial->errorString());
+    emit portLost(portName);
 }
 
 float serialPortHandler::convertBytesToFloat(const QByteArray &data)
@@ -104,9 +152,7 @@ QString serialPortHandler::hexBytesSerial(QByteArray &cmd)
 
 void serialPortHandler::readData()
 {
-    qDebug()<<"------------------------------------------------------------------------------------";
-    emit portOpening("------------------------------------------------------------------------------------");
-    QByteArray ResponseData;
+    qint64 readyReadNs = monotonicClock::nowNs();
 
     // Read data from the serial port
     if (serial->bytesAvailable() == 0) {
@@ -114,20 +160,77 @@ void serialPortHandler::readData()
         return;  // Early return if no data is available
     }
 
-    // Create a QMutexLocker to manage the mutex
-    QMutexLocker locker(&bufferMutex); // Lock the mutex
+    if (serial->bytesAvailable() >= std::numeric_limits<int>::max()) {
+        qWarning() << "Attempt to append too much data to QByteArray!";
+        return;
+    }
 
+    qint64 rxNs = monotonicClock::nowNs();
+    QByteArray chunk = serial->readAll();
+    emit rawTraffic(0x00, chunk, rxNs);
 
-    if (serial->bytesAvailable() < std::numeric_limits<int>::max()) {
-        buffer.append(serial->readAll()); // Append only if it won't exceed max size
-        if (!buffer.isEmpty()) {
-                emit dataReceived(); // Signal data has been received
-            }
-    } else {
-        qWarning() << "Attempt to append too much data to QByteArray!";
+    processChunk(chunk, readyReadNs, rxNs);
+}
+
+//A response is "ACK" + 1 data byte + XOR checksum of the first 4 bytes
+bool serialPortHandler::isFramePrefix(const char *data, int size)
+{
+    static const char header[] = { 0x41, 0x43, 0x4B };
+
+    for (int i = 0; i < size && i < 3; ++i) {
+        if (data[i] != header[i]) {
+            return false;
+        }
+    }
+
+    if (size < FrameSize) {
+        return true;
+    }
+
+    quint8 checksum = 0;
+    for (int i = 0; i < FrameSize - 1; ++i) {
+        checksum ^= static_cast<quint8>(data[i]);
+    }
+    return checksum == static_cast<quint8>(data[FrameSize - 1]);
+}
+
+void serialPortHandler::resyncBuffer()
+{
+    // One pass, each start offset checks at most FrameSize bytes
+    int start = 0;
+    while (start < buffer.size() && !isFramePrefix(buffer.constData() + start, buffer.size() - start)) {
+        ++start;
+    }
+
+    if (start > 0) {
+        executeWriteToNotes("Not a response, dropped bytes: "+buffer.left(start).toHex());
+        buffer.remove(0, start);
+    }
+}
+
+void serialPortHandler::processChunk(const QByteArray &chunk, qint64 readyReadNs, qint64 rxNs)
+{
+    if (chunk.isEmpty()) {
         return;
     }
 
+    qDebug()<<"------------------------------------------------------------------------------------";
+    emit portOpening("------------------------------------------------------------------------------------");
+    QByteArray ResponseData;
+
+    // Create a QMutexLocker to manage the mutex
+    QMutexLocker locker(&bufferMutex); // Lock the mutex
+
+    frameTiming.chunks.append({rxNs, chunk.size()});
+    frameTiming.readyReadNs = readyReadNs;
+    buffer.append(chunk);
+    if (!buffer.isEmpty()) {
+            emit dataReceived(); // Signal data has been received
+        }
+
+    // Drop bytes that can not start a response, buffer stays below one frame after the loop
+    resyncBuffer();
+
     qDebug()<<buffer.toHex()<<" Raw buffer data";
     qDebug()<<buffer.size()<<" :size";
     emit portOpening("Raw readyRead data: "+buffer.toHex());
@@ -135,58 +238,72 @@ void serialPortHandler::readData()
 
     //Direct taking msgId from mainWindow
     quint8 msgId = id;
-    //powerId to avoid that warning QByteRef calling out of bond error
-    quint8 powerId = 0x00;
 
-    if(msgId == 0x01)
+    while(buffer.size() >= FrameSize)
     {
-        qDebug() << "msgId:" <<hex<<msgId;
+        //resyncBuffer() only leaves a full frame at the front when header and checksum match
+        QByteArray ResponseData = buffer.left(FrameSize);
+        buffer.remove(0, FrameSize);
 
-        if(buffer.size() == 5
-                && static_cast<unsigned char>(buffer[0]) == 0x41
-                && static_cast<unsigned char>(buffer[1]) == 0x43
-                && static_cast<unsigned char>(buffer[2]) == 0x4B
-                && static_cast<unsigned char>(buffer[4]) == chkSum(buffer))
+        //powerId to avoid that warning QByteRef calling out of bond error
+        quint8 powerId = 0x00;
+
+        if(msgId == 0x01)
         {
+            qDebug() << "msgId:" <<hex<<msgId;
             powerId = 0x01;
-            ResponseData = buffer;
-            buffer.clear();
             executeWriteToNotes("Set User Value received bytes: "+ResponseData.toHex());
         }
+        else if(msgId == 0x02)
+        {
+            qDebug() << "msgId:" <<hex<<msgId;
+            powerId = 0x02;
+            executeWriteToNotes("KYC Value received bytes: "+ResponseData.toHex());
+        }
         else
         {
-            executeWriteToNotes("Required 5 bytes Received bytes: "+QString::number(buffer.size())
-                                     +" "+buffer.toHex());
+            //do nothing
+            qDebug()<<"do nothing not a specified size/unknown msgId";
+            executeWriteToNotes("Fatal Error 404");
         }
 
-    }
-    else if(msgId == 0x02)
-    {
-        qDebug() << "msgId:" <<hex<<msgId;
+        switch(powerId)
+        {
+        case 0x01:
+        {
+            //set user response
+            dispatchFrame(msgId, ResponseData);
+            emit guiDisplay(ResponseData);
+        }
+            break;
 
-        if(buffer.size() == 5
-                && static_cast<unsigned char>(buffer[0]) == 0x41
-                && static_cast<unsigned char>(buffer[1]) == 0x43
-                && static_cast<unsigned char>(buffer[2]) == 0x4B
-                && static_cast<unsigned char>(buffer[4]) == chkSum(buffer))
+        case 0x02:
         {
-            powerId = 0x02;
-            ResponseData = buffer;
-            buffer.clear();
-            executeWriteToNotes("KYC Value received bytes: "+ResponseData.toHex());
+            // kys response
+            dispatchFrame(msgId, ResponseData);
+            emit guiDisplay(ResponseData);
         }
-        else
+            break;
+
+        default:
         {
-            executeWriteToNotes("Required 5 bytes Received bytes: "+QString::number(buffer.size())
-                                     +" "+buffer.toHex());
+            qDebug() << "Unknown powerId: " <<hex << powerId << " with data: " << ResponseData.size();
+            frameTiming.chunks.clear();
+        }
+
         }
 
+        resyncBuffer();
+    }
+
+    if(buffer.isEmpty())
+    {
+        frameTiming.chunks.clear();
     }
     else
     {
-        //do nothing
-        qDebug()<<"do nothing not a specified size/unknown msgId";
-        executeWriteToNotes("Fatal Error 404");
+        executeWriteToNotes("Required 5 bytes Received bytes: "+QString::number(buffer.size())
+                                 +" "+buffer.toHex());
     }
 
 
@@ -200,9 +317,6 @@ void serialPortHandler::readData()
 
     void MainWindow::on_pushButton_cpcHI_1_clicked()
     {
-        // Start the timeout timer
-        responseTimer->start(2000); // 2 Sec timer
-
         QByteArray command;
 
         command.append(0x47); //1
@@ -219,38 +333,38 @@ void serialPortHandler::readData()
         writeToNotes("cpcHi1 cmd sent : " + hexBytes(command));
 
 
-        emit sendMsgId(0x05);
-        serialObj->writeData(command);
+        // sends msgId, writes command and starts adaptive response timer (RTT based)
+        sendCommand(command, 0x05);
     }
 
     */
 
     // #############################################################################################
 
-    switch(powerId)
-    {
-    case 0x01:
-    {
-        //set user response
-        emit guiDisplay(ResponseData);
-    }
-        break;
+}
 
-    case 0x02:
-    {
-        // kys response
-        emit guiDisplay(ResponseData);
-    }
-        break;
+void serialPortHandler::onBytesWritten(qint64 bytes)
+{
+    Q_UNUSED(bytes)
 
-    default:
+    // First flush after writeData() : command left the process
+    if (frameTiming.txQueuedNs >= 0 && frameTiming.txNs < 0)
     {
-        qDebug() << "Unknown powerId: " <<hex << powerId << " with data: " << ResponseData.size();
-
+        frameTiming.txNs = monotonicClock::nowNs();
     }
+}
 
-    }
+void serialPortHandler::dispatchFrame(quint8 msgId, const QByteArray &data)
+{
+    frameTiming.msgId = msgId;
+    frameTiming.data = data;
+    frameTiming.baudRate = serial->baudRate();
+    frameTiming.dispatchNs = monotonicClock::nowNs();
+
+    emit frameTimed(frameTiming);
 
+    // next frame without a new command (unsolicited) has no Tx time
+    frameTiming = serialFrame();
 }
 
 void serialPortHandler::recvMsgId(quint8 id)
@@ -258,4 +372,5 @@ void serialPortHandler::recvMsgId(quint8 id)
     qDebug() << "Received id:" <<hex<< id;
     this->id = id;
     buffer.clear();
+    frameTiming.chunks.clear();
 }
@@ -7,6 +7,40 @@
 #include <QDebug>
 #include <QMutexLocker>
 #include <QMutex>
+#include "monotonicclock.h"
+
+#include <QVector>
+
+// One read from the port, stamped just before readAll()
+struct rxChunk
+{
+    qint64 timestampNs;
+    int size;
+};
+
+// Validated response with its timing (all times from monotonicClock::nowNs(), -1 = not stamped)
+struct serialFrame
+{
+    quint8 msgId = 0x00;
+    QByteArray data;
+    qint32 baudRate = 0;
+    qint64 txQueuedNs = -1;   // writeData() called, bytes only in Qt's write buffer (-1 if no command)
+    qint64 txNs = -1;         // bytesWritten() : bytes handed to the OS by the event loop
+    int txBytes = 0;
+    QVector<rxChunk> chunks;  // every read that built this frame
+    qint64 readyReadNs = 0;   // entry of readData() for the last chunk
+    qint64 dispatchNs = 0;    // frame handed to GUI
+};
+
+// Settings applied on every open, kept so a replugged device gets the same session
+struct portConfig
+{
+    qint32 baudRate = 921600;
+    QSerialPort::DataBits dataBits = QSerialPort::Data8;
+    QSerialPort::Parity parity = QSerialPort::NoParity;
+    QSerialPort::StopBits stopBits = QSerialPort::OneStop;
+    QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
+};
 
 // Forward declaration of MainWindow
 class MainWindow;
@@ -33,21 +67,43 @@ public:
             if(serial->isOpen())
             {
                 buffer.clear();
+                qint64 txQueuedNs = monotonicClock::nowNs();
+                emit rawTraffic(0x01, data, txQueuedNs);
                 serial->write(data);
+
+                // txNs is filled by onBytesWritten() when the write really happens
+                frameTiming = serialFrame();
+                frameTiming.txQueuedNs = txQueuedNs;
+                frameTiming.txBytes = data.size();
             }
         }
     }
 
     QStringList availablePorts();
 
+    bool isPortOpen() const { return serial->isOpen(); }
+
     void setPORTNAME(const QString &portName);
 
+    //Reopen after replug with the saved portConfig (port name may have changed)
+    bool reopenPort(const QString &portName);
+    void closePort();
+    QString currentPortName() const { return serial->portName(); }
+
     float convertBytesToFloat(const QByteArray &data);
 
     quint8 chkSum(const QByteArray &data);
 
     QString hexBytesSerial(QByteArray &cmd);
 
+    //Frame parsing of one received chunk, readData() feeds it from the port.
+    //Public so bench/ can drive the parser without a port.
+    void processChunk(const QByteArray &chunk, qint64 readyReadNs, qint64 rxNs);
+    int bufferedBytes() const { return buffer.size(); }
+
+    static const int FrameSize = 5; // every response is 5 bytes, buffer is always shorter after processChunk()
+
+
 
 signals:
 
@@ -55,14 +111,24 @@ signals:
 
     void guiDisplay(const QByteArray &byteArrayData); //signal for sending byteArray data to GUI : QByteArray
 
+    void frameTimed(const serialFrame &frame); //same response as guiDisplay with Tx/Rx timestamps
+
+    void rawTraffic(quint8 direction, const QByteArray &data, qint64 timestampNs); //every write (0x01) and read (0x00), for recording
+
     void dataReceived();
 
     void executeWriteToNotes(const QString &dataNotes);
 
+    void portLost(const QString &portName); //device unplugged or port failed, port is closed
+
 private slots:
 
     void readData();
 
+    void handleError(QSerialPort::SerialPortError error);
+
+    void onBytesWritten(qint64 bytes);
+
 public slots:
 
     void recvMsgId(quint8 id);
@@ -71,7 +137,18 @@ private:
     QSerialPort *serial;
     QByteArray  buffer;
 
-    quint8 id;
+    quint8 id = 0x00;
+
+    portConfig config;
+    bool openPort(const QString &portName);
+
+    //timing of the frame being received
+    serialFrame frameTiming;
+    void dispatchFrame(quint8 msgId, const QByteArray &data);
+
+    //drop leading bytes until the buffer can be the start of a response
+    static bool isFramePrefix(const char *data, int size);
+    void resyncBuffer();
 
     //mutex variable
     QMutex bufferMutex; // Mutex for thread-safe access to the buffer
@@ -0,0 +1,160 @@
+#include "timinganalysis.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QHeaderView>
+
+timingAnalysis::timingAnalysis(QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle("Timing Analysis");
+    setModal(false);
+    resize(820, 420);
+
+    table = new QTableWidget(0, 10, this);
+    table->setHorizontalHeaderLabels({"msgId", "Bytes", "Reads", "Tx flush ms", "Turnaround ms", "Host backlog ms",
+                                      "Device (est) ms", "Max read gap ms", "Frame gap ms",
+                                      "readyRead->dispatch us"});
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+
+    summary = new QLabel(this);
+
+    QPushButton *clearButton = new QPushButton("Clear", this);
+    connect(clearButton, &QPushButton::clicked, this, &timingAnalysis::clearFrames);
+
+    QHBoxLayout *bottom = new QHBoxLayout;
+    bottom->addWidget(summary, 1);
+    bottom->addWidget(clearButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(table);
+    layout->addLayout(bottom);
+
+    updateSummary();
+}
+
+void timingAnalysis::addFrame(const serialFrame &frame)
+{
+    if (frame.chunks.isEmpty())
+        return;
+
+    const qint64 firstRxNs = frame.chunks.first().timestampNs;
+    // 10 bits per byte on the wire (start + 8 data + stop)
+    const double msPerByte = frame.baudRate > 0 ? 10.0 * 1000.0 / frame.baudRate : 0.0;
+
+    frameStats stats;
+    stats.msgId = frame.msgId;
+    stats.bytes = frame.data.size();
+    stats.chunks = frame.chunks.size();
+    stats.hostBacklogMs = frame.chunks.first().size * msPerByte;
+
+    // bytesWritten() normally comes before any answer, fall back to queue time if not
+    qint64 txNs = frame.txNs >= 0 ? frame.txNs : frame.txQueuedNs;
+    stats.txFlushMs = frame.txNs >= 0 ? (frame.txNs - frame.txQueuedNs) / 1000000.0 : -1.0;
+    stats.turnaroundMs = txNs >= 0 ? (firstRxNs - txNs) / 1000000.0 : -1.0;
+    stats.deviceMs = txNs >= 0 ? qMax(0.0, stats.turnaroundMs - stats.hostBacklogMs - frame.txBytes * msPerByte) : -1.0;
+    stats.frameGapMs = lastRxNs >= 0 ? (firstRxNs - lastRxNs) / 1000000.0 : -1.0;
+    stats.dispatchUs = (frame.dispatchNs - frame.readyReadNs) / 1000.0;
+
+    stats.maxChunkGapMs = 0.0;
+    for (int i = 1; i < frame.chunks.size(); ++i)
+    {
+        double gap = (frame.chunks[i].timestampNs - frame.chunks[i - 1].timestampNs) / 1000000.0;
+        stats.maxChunkGapMs = qMax(stats.maxChunkGapMs, gap);
+    }
+
+    lastRxNs = frame.chunks.last().timestampNs;
+
+    frames.append(stats);
+    if (frames.size() > MaxFrames)
+        frames.removeFirst();
+
+    // Table is only kept up to date while visible, showEvent() rebuilds it
+    if (isVisible())
+    {
+        appendRow(stats);
+        updateSummary();
+    }
+}
+
+void timingAnalysis::clearFrames()
+{
+    frames.clear();
+    lastRxNs = -1;
+    table->setRowCount(0);
+    updateSummary();
+}
+
+void timingAnalysis::showEvent(QShowEvent *event)
+{
+    table->setRowCount(0);
+    for (const frameStats &stats : frames)
+    {
+        appendRow(stats);
+    }
+    updateSummary();
+
+    QDialog::showEvent(event);
+}
+
+void timingAnalysis::appendRow(const frameStats &stats)
+{
+    auto ms = [](double value) { return value < 0 ? QString("-") : QString::number(value, 'f', 3); };
+
+    if (table->rowCount() >= MaxFrames)
+        table->removeRow(0);
+
+    int row = table->rowCount();
+    table->insertRow(row);
+
+    QStringList cells = { "0x"+QString::number(stats.msgId, 16), QString::number(stats.bytes),
+                          QString::number(stats.chunks), ms(stats.txFlushMs), ms(stats.turnaroundMs), ms(stats.hostBacklogMs),
+                          ms(stats.deviceMs), ms(stats.maxChunkGapMs), ms(stats.frameGapMs),
+                          QString::number(stats.dispatchUs, 'f', 1) };
+
+    for (int column = 0; column < cells.size(); ++column)
+    {
+        table->setItem(row, column, new QTableWidgetItem(cells[column]));
+    }
+    table->scrollToBottom();
+}
+
+void timingAnalysis::updateSummary()
+{
+    double txFlush = 0.0, turnaround = 0.0, host = 0.0, device = 0.0, dispatch = 0.0, maxDispatch = 0.0;
+    int timed = 0, flushed = 0;
+
+    for (const frameStats &stats : frames)
+    {
+        if (stats.turnaroundMs >= 0)
+        {
+            turnaround += stats.turnaroundMs;
+            device += stats.deviceMs;
+            timed++;
+        }
+        if (stats.txFlushMs >= 0)
+        {
+            txFlush += stats.txFlushMs;
+            flushed++;
+        }
+        host += stats.hostBacklogMs;
+        dispatch += stats.dispatchUs;
+        maxDispatch = qMax(maxDispatch, stats.dispatchUs);
+    }
+
+    if (frames.isEmpty())
+    {
+        summary->setText("No frames yet");
+        return;
+    }
+
+    summary->setText("Frames: "+QString::number(frames.size())
+                     +"   avg Tx flush: "+(flushed ? QString::number(txFlush / flushed, 'f', 3) : QString("-"))+" ms"
+                     +"   avg turnaround: "+(timed ? QString::number(turnaround / timed, 'f', 3) : QString("-"))+" ms"
+                     +"   avg device (est): "+(timed ? QString::number(device / timed, 'f', 3) : QString("-"))+" ms"
+                     +"   avg host backlog: "+QString::number(host / frames.size(), 'f', 3)+" ms"
+                     +"   readyRead->dispatch avg/max: "+QString::number(dispatch / frames.size(), 'f', 1)
+                     +" / "+QString::number(maxDispatch, 'f', 1)+" us");
+}
@@ -0,0 +1,62 @@
+#ifndef TIMINGANALYSIS_H
+#define TIMINGANALYSIS_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QLabel>
+#include <QVector>
+#include "serialporthandler.h"
+
+// Non-modal view of response timing, separates host latency from device latency.
+//
+// Per frame (times from monotonicClock::nowNs()):
+//   Tx flush        writeData() until bytesWritten() : command sat in Qt's write buffer
+//                   while the GUI thread was busy (host latency on the Tx side)
+//   turnaround      first Rx chunk - bytesWritten()
+//   host backlog    wire time of the bytes delivered by the first read : they were all
+//                   waiting in the driver, so the first byte waited at least that long
+//   device (est)    turnaround - host backlog - Tx wire time, upper bound of device response time
+//   max chunk gap   largest gap between reads inside the frame
+//   frame gap       first read of this frame - last read of previous frame
+//   readyRead->dispatch  readData() entry for last chunk until frame handed to GUI
+class timingAnalysis : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit timingAnalysis(QWidget *parent = nullptr);
+
+public slots:
+    void addFrame(const serialFrame &frame);
+    void clearFrames();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private:
+    struct frameStats
+    {
+        quint8 msgId;
+        int bytes;
+        int chunks;
+        double txFlushMs;      // -1 when no Tx time
+        double turnaroundMs;   // -1 when no Tx time
+        double hostBacklogMs;
+        double deviceMs;       // -1 when no Tx time
+        double maxChunkGapMs;
+        double frameGapMs;     // -1 for first frame
+        double dispatchUs;
+    };
+
+    void appendRow(const frameStats &stats);
+    void updateSummary();
+
+    QTableWidget *table;
+    QLabel *summary;
+
+    QVector<frameStats> frames;
+    qint64 lastRxNs = -1; // -1 = no frame yet
+
+    static const int MaxFrames = 1000;
+};
+
+#endif // TIMINGANALYSIS_H
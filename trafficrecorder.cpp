@@ -0,0 +1,337 @@
+#include "trafficrecorder.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+namespace
+{
+const char FileMagic[4]  = { 'U', 'R', 'E', 'C' };
+const char ChunkMagic[4] = { 'U', 'R', 'C', 'K' };
+const quint16 FormatVersion = 1;
+const int RecordHeaderSize = 12; // i64 timestamp | u8 channel | u8 direction | u16 length
+
+QByteArray encodeChunkHeader(const trafficRecorder::ChunkHeader &h)
+{
+    QByteArray out(trafficRecorder::ChunkHeaderSize, '\0');
+    uchar *p = reinterpret_cast<uchar *>(out.data());
+
+    memcpy(p, ChunkMagic, 4);
+    qToLittleEndian<quint16>(FormatVersion, p + 4);
+    qToLittleEndian<quint16>(trafficRecorder::ChunkHeaderSize, p + 6);
+    qToLittleEndian<quint32>(h.sequence, p + 8);
+    qToLittleEndian<quint32>(h.recordCount, p + 12);
+    qToLittleEndian<quint32>(h.droppedRecords, p + 16);
+    qToLittleEndian<quint32>(h.rawSize, p + 20);
+    qToLittleEndian<quint32>(h.compressedSize, p + 24);
+    qToLittleEndian<qint64>(h.firstTimestampNs, p + 28);
+    qToLittleEndian<qint64>(h.lastTimestampNs, p + 36);
+    qToLittleEndian<quint16>(h.payloadCrc, p + 44);
+    // header crc covers everything before it
+    qToLittleEndian<quint16>(qChecksum(out.constData(), 46), p + 46);
+
+    return out;
+}
+
+bool decodeChunkHeader(const QByteArray &in, trafficRecorder::ChunkHeader *h)
+{
+    if (in.size() < trafficRecorder::ChunkHeaderSize || memcmp(in.constData(), ChunkMagic, 4) != 0)
+        return false;
+
+    const uchar *p = reinterpret_cast<const uchar *>(in.constData());
+
+    if (qFromLittleEndian<quint16>(p + 46) != qChecksum(in.constData(), 46))
+        return false;
+
+    h->sequence         = qFromLittleEndian<quint32>(p + 8);
+    h->recordCount      = qFromLittleEndian<quint32>(p + 12);
+    h->droppedRecords   = qFromLittleEndian<quint32>(p + 16);
+    h->rawSize          = qFromLittleEndian<quint32>(p + 20);
+    h->compressedSize   = qFromLittleEndian<quint32>(p + 24);
+    h->firstTimestampNs = qFromLittleEndian<qint64>(p + 28);
+    h->lastTimestampNs  = qFromLittleEndian<qint64>(p + 36);
+    h->payloadCrc       = qFromLittleEndian<quint16>(p + 44);
+    return true;
+}
+}
+
+trafficRecorder::trafficRecorder(QObject *parent) : QThread(parent)
+{
+}
+
+trafficRecorder::~trafficRecorder()
+{
+    stopRecording();
+}
+
+bool trafficRecorder::startRecording(const QString &fileName)
+{
+    if (isRecording())
+    {
+        qWarning() << "Recording already running";
+        return false;
+    }
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Failed to open recording file" << fileName;
+        emit recordingStatus("Failed to open recording file "+fileName);
+        return false;
+    }
+
+    QByteArray header(FileHeaderSize, '\0');
+    uchar *p = reinterpret_cast<uchar *>(header.data());
+    memcpy(p, FileMagic, 4);
+    qToLittleEndian<quint16>(FormatVersion, p + 4);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), p + 8);
+    qToLittleEndian<qint64>(monotonicClock::nowNs(), p + 16);
+    if (file.write(header) != header.size())
+    {
+        qWarning() << "Recording write failed:" << file.errorString();
+        emit recordingStatus("Recording write failed : "+file.errorString());
+        file.close();
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&bufferMutex);
+        active = PendingChunk();
+        queue.clear();
+        droppedRecords = 0;
+        writeFailed = false;
+        running = true;
+    }
+
+    sequence = 0;
+    bytesIn = 0;
+    bytesOut = FileHeaderSize;
+
+    start(QThread::LowPriority);
+
+    emit recordingStatus("Recording started : "+fileName);
+    return true;
+}
+
+void trafficRecorder::stopRecording()
+{
+    {
+        QMutexLocker locker(&bufferMutex);
+
+        // Also called after a write error : writer already stopped, file still open
+        if (!running && !file.isOpen())
+            return;
+
+        // Last chunk is always written, it also carries a pending drop count
+        if (running && (active.recordCount > 0 || droppedRecords > 0))
+            sealActiveChunk(true);
+
+        running = false;
+        chunkReady.wakeOne();
+    }
+
+    wait(); // writer drains the queue before it exits
+    file.close();
+
+    if (writeFailed)
+    {
+        emit recordingStatus("Recording stopped after write error : "+QString::number(sequence)+" chunks written");
+        return;
+    }
+
+    double ratio = bytesIn > 0 ? static_cast<double>(bytesOut) / bytesIn : 0.0;
+    emit recordingStatus("Recording stopped : "+QString::number(sequence)+" chunks, "
+                         +QString::number(bytesIn)+" bytes in, "+QString::number(bytesOut)
+                         +" bytes on disk ("+QString::number(ratio * 100.0, 'f', 1)+" %)");
+}
+
+bool trafficRecorder::isRecording() const
+{
+    QMutexLocker locker(&bufferMutex);
+    return running;
+}
+
+void trafficRecorder::record(quint8 channel, Direction direction, const QByteArray &data, qint64 timestampNs)
+{
+    if (data.isEmpty())
+        return;
+
+    QMutexLocker locker(&bufferMutex);
+
+    if (!running)
+        return;
+
+    if (active.recordCount == 0)
+    {
+        active.firstTimestampNs = timestampNs;
+        active.raw.reserve(chunkSize + RecordHeaderSize + 0xFFFF);
+    }
+
+    // length field is u16, bigger reads are split into several records
+    int offset = 0;
+    while (offset < data.size())
+    {
+        int length = qMin(data.size() - offset, 0xFFFF);
+
+        uchar recordHeader[RecordHeaderSize];
+        qToLittleEndian<qint64>(timestampNs, recordHeader);
+        recordHeader[8] = channel;
+        recordHeader[9] = direction;
+        qToLittleEndian<quint16>(static_cast<quint16>(length), recordHeader + 10);
+
+        active.raw.append(reinterpret_cast<const char *>(recordHeader), RecordHeaderSize);
+        active.raw.append(data.constData() + offset, length);
+        active.recordCount++;
+
+        offset += length;
+    }
+    active.lastTimestampNs = timestampNs;
+
+    if (active.raw.size() >= chunkSize)
+        sealActiveChunk();
+}
+
+void trafficRecorder::sealActiveChunk(bool force)
+{
+    if (!force && queue.size() >= maxQueuedChunks)
+    {
+        // Disk is not keeping up : drop instead of growing without bound
+        droppedRecords += active.recordCount;
+        active = PendingChunk();
+        return;
+    }
+
+    active.droppedRecords = droppedRecords;
+    droppedRecords = 0;
+
+    queue.enqueue(active);
+    active = PendingChunk();
+    chunkReady.wakeOne();
+}
+
+void trafficRecorder::run()
+{
+    QMutexLocker locker(&bufferMutex);
+
+    while (true)
+    {
+        if (queue.isEmpty())
+        {
+            if (!running)
+                break;
+
+            // Timeout : write the partial chunk so a crash loses at most flushIntervalMs
+            if (!chunkReady.wait(&bufferMutex, static_cast<unsigned long>(flushIntervalMs))
+                    && active.recordCount > 0)
+            {
+                sealActiveChunk();
+            }
+            continue;
+        }
+
+        PendingChunk chunk = queue.dequeue();
+
+        locker.unlock();
+        bool written = writeChunk(chunk);
+        locker.relock();
+
+        if (!written)
+        {
+            // Stop on first error : one report, no more records accepted
+            running = false;
+            writeFailed = true;
+            queue.clear();
+            active = PendingChunk();
+            droppedRecords = 0;
+            break;
+        }
+    }
+}
+
+bool trafficRecorder::writeChunk(const PendingChunk &chunk)
+{
+    QByteArray compressed = qCompress(chunk.raw, compressionLevel);
+
+    ChunkHeader header;
+    header.sequence = sequence++;
+    header.recordCount = chunk.recordCount;
+    header.droppedRecords = chunk.droppedRecords;
+    header.rawSize = static_cast<quint32>(chunk.raw.size());
+    header.compressedSize = static_cast<quint32>(compressed.size());
+    header.firstTimestampNs = chunk.firstTimestampNs;
+    header.lastTimestampNs = chunk.lastTimestampNs;
+    header.payloadCrc = qChecksum(compressed.constData(), static_cast<uint>(compressed.size()));
+
+    QByteArray headerBytes = encodeChunkHeader(header);
+
+    if (file.write(headerBytes) != headerBytes.size() || file.write(compressed) != compressed.size())
+    {
+        qWarning() << "Recording write failed:" << file.errorString();
+        emit recordingStatus("Recording write failed : "+file.errorString());
+        return false;
+    }
+
+    // hand over to the OS, no fsync : chunk CRCs make a torn tail detectable
+    file.flush();
+
+    bytesIn += static_cast<quint64>(chunk.raw.size());
+    bytesOut += static_cast<quint64>(headerBytes.size() + compressed.size());
+
+    if (chunk.droppedRecords > 0)
+        emit recordingStatus("Recording dropped "+QString::number(chunk.droppedRecords)+" records (disk too slow)");
+
+    return true;
+}
+
+QVector<qint64> trafficRecorder::scanChunks(QFile &file)
+{
+    QVector<qint64> offsets;
+    qint64 pos = FileHeaderSize;
+    const qint64 fileSize = file.size();
+
+    while (pos + ChunkHeaderSize <= fileSize)
+    {
+        file.seek(pos);
+        ChunkHeader header;
+
+        if (decodeChunkHeader(file.read(ChunkHeaderSize), &header)
+                && pos + ChunkHeaderSize + header.compressedSize <= fileSize)
+        {
+            offsets.append(pos);
+            pos += ChunkHeaderSize + header.compressedSize;
+            continue;
+        }
+
+        // Corrupt or torn chunk : resync on the next chunk magic
+        const int window = 64 * 1024;
+        qint64 next = -1;
+        for (qint64 searchPos = pos + 1; searchPos < fileSize && next < 0; searchPos += window - 3)
+        {
+            file.seek(searchPos);
+            int index = file.read(window).indexOf(QByteArray(ChunkMagic, 4));
+            if (index >= 0)
+                next = searchPos + index;
+        }
+
+        if (next < 0)
+            break;
+        pos = next;
+    }
+
+    return offsets;
+}
+
+bool trafficRecorder::readChunkAt(QFile &file, qint64 offset, ChunkHeader *header, QByteArray *rawRecords)
+{
+    if (!file.seek(offset) || !decodeChunkHeader(file.read(ChunkHeaderSize), header))
+        return false;
+
+    QByteArray compressed = file.read(header->compressedSize);
+    if (compressed.size() != static_cast<int>(header->compressedSize)
+            || qChecksum(compressed.constData(), static_cast<uint>(compressed.size())) != header->payloadCrc)
+    {
+        return false;
+    }
+
+    *rawRecords = qUncompress(compressed);
+    return rawRecords->size() == static_cast<int>(header->rawSize);
+}
@@ -0,0 +1,111 @@
+#ifndef TRAFFICRECORDER_H
+#define TRAFFICRECORDER_H
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QVector>
+#include <QDebug>
+#include "monotonicclock.h"
+
+// Long running traffic recorder for soak tests.
+//
+// File layout (all integers little-endian):
+//   file header  : "UREC" | u16 version | u16 reserved | i64 epochMs | i64 monotonicNs
+//                  (wall clock at monotonicClock::nowNs() time monotonicNs, to map record timestamps to dates)
+//   chunk ...    : ChunkHeader | qCompress() payload
+//   payload      : records, each i64 timestampNs | u8 channel | u8 direction | u16 length | bytes
+//
+// Every chunk carries its own magic, sizes, time range and CRCs, so a reader can seek
+// chunk to chunk (or binary search on time) and after a crash resync on the next magic.
+class trafficRecorder : public QThread
+{
+    Q_OBJECT
+public:
+    enum Direction : quint8
+    {
+        Rx = 0x00,
+        Tx = 0x01
+    };
+
+    struct ChunkHeader
+    {
+        quint32 sequence = 0;
+        quint32 recordCount = 0;
+        quint32 droppedRecords = 0;  // records lost before this chunk because queue was full
+        quint32 rawSize = 0;
+        quint32 compressedSize = 0;
+        qint64  firstTimestampNs = 0;
+        qint64  lastTimestampNs = 0;
+        quint16 payloadCrc = 0;
+    };
+
+    static const int FileHeaderSize = 24;
+    static const int ChunkHeaderSize = 48;
+
+    explicit trafficRecorder(QObject *parent = nullptr);
+    ~trafficRecorder();
+
+    bool startRecording(const QString &fileName);
+    void stopRecording();
+    bool isRecording() const;
+
+    // Called from the serial side, cheap : only appends to the in memory block
+    void record(quint8 channel, Direction direction, const QByteArray &data, qint64 timestampNs);
+
+    // Reader side helpers (seeking and crash recovery)
+    static QVector<qint64> scanChunks(QFile &file);
+    static bool readChunkAt(QFile &file, qint64 offset, ChunkHeader *header, QByteArray *rawRecords);
+
+    //Tuning
+    void setChunkSize(int bytes) { chunkSize = bytes; }
+    void setFlushInterval(int ms) { flushIntervalMs = ms; }
+    void setCompressionLevel(int level) { compressionLevel = level; }
+    void setMaxQueuedChunks(int count) { maxQueuedChunks = count; }
+
+signals:
+    void recordingStatus(const QString &status);
+
+protected:
+    void run() override;
+
+private:
+    struct PendingChunk
+    {
+        QByteArray raw;
+        quint32 recordCount = 0;
+        quint32 droppedRecords = 0;
+        qint64 firstTimestampNs = 0;
+        qint64 lastTimestampNs = 0;
+    };
+
+    void sealActiveChunk(bool force = false);  // bufferMutex must be held, force ignores the queue limit
+    bool writeChunk(const PendingChunk &chunk);
+
+    QFile file;
+
+    //shared between record() and writer thread
+    mutable QMutex bufferMutex;
+    QWaitCondition chunkReady;
+    PendingChunk active;
+    QQueue<PendingChunk> queue;
+    quint32 droppedRecords = 0;
+    bool running = false;
+    bool writeFailed = false;   // writer stopped on first write error
+
+    //writer thread only
+    quint32 sequence = 0;
+    quint64 bytesIn = 0;
+    quint64 bytesOut = 0;
+
+    int chunkSize = 64 * 1024;
+    int flushIntervalMs = 1000;  // partial chunk is written at least this often (crash loss bound)
+    int compressionLevel = 1;    // zlib level, 1 is fastest
+    int maxQueuedChunks = 64;    // bounds memory if disk can't keep up
+};
+
+#endif // TRAFFICRECORDER_H